@@ -5,6 +5,15 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <pthread.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
 
 #define N 4
 #define BLOCK 2
@@ -17,6 +26,23 @@ int base_solved[N][N] = {
   {4, 3, 2, 1}
 };
 
+/*
+ * xorshift32 random generator. The state is per thread so that batch workers
+ * (see run_batch) neither contend on nor share the sequence of rand().
+ */
+static _Thread_local unsigned rng_state = 2463534242u;
+
+void rng_seed(unsigned seed) {
+  rng_state = seed ? seed : 2463534242u;
+}
+
+int rng_rand(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return (int)(rng_state & 0x7fffffff);
+}
+
 void copy_board(int dst[N][N], int src[N][N]) {
   for (int row = 0; row < N; row++) {
     for (int col = 0; col < N; col++) {
@@ -113,58 +139,449 @@ void print_board(int a[N][N], double elapsed_seconds, int score) {
   return;
 }
 
-int is_valid(int a[N][N], int r, int c, int v) {
-  // check row
-  for (int i=0; i<N; i++) {
-    if (a[r][i] == v) return 0;
+/*
+ * Constraint regions.
+ *
+ * Every constraint of a puzzle is a region: a set of cells that must hold
+ * distinct values (rows, columns, blocks, diagonals, jigsaw pieces, killer
+ * cages), optionally with a required sum (killer cages). variant_build()
+ * precomputes the regions and, for every cell, the list of regions it belongs
+ * to, so the solver only ever works with per-region bitmasks no matter which
+ * variant is played.
+ */
+#define CELLS (N * N)
+#define FULL_MASK ((1u << N) - 1)
+#define MAX_REGIONS (3 * N + 2 + CELLS)
+#define MAX_CELL_REGIONS 5
+
+enum {
+  VARIANT_CLASSIC = 0,
+  VARIANT_DIAGONAL,
+  VARIANT_JIGSAW,
+  VARIANT_KILLER
+};
+
+enum {
+  REGION_ROW = 0,
+  REGION_COL,
+  REGION_BLOCK,
+  REGION_DIAGONAL,
+  REGION_CAGE
+};
+
+typedef struct {
+  int kind;      /* REGION_* */
+  int size;
+  int cells[N];  /* cell index r*N + c */
+  int sum;       /* required sum of a killer cage, 0 if none */
+} region;
+
+typedef struct {
+  int kind;               /* VARIANT_* */
+  int block_of[CELLS];    /* block, or jigsaw piece, of every cell */
+  int cage_of[CELLS];     /* killer cage of every cell, -1 if none */
+  int cage_count;
+  int cage_sum[CELLS];
+
+  /* derived by variant_build() */
+  int region_count;
+  region regions[MAX_REGIONS];
+  int cell_region_count[CELLS];
+  int cell_regions[CELLS][MAX_CELL_REGIONS];
+} variant;
+
+/* the variant being played; set up once before solving or generating */
+variant game_variant;
+
+static int add_region(variant *vr, int kind, int sum) {
+  region *rg = &vr->regions[vr->region_count];
+  rg->kind = kind;
+  rg->size = 0;
+  rg->sum = sum;
+  return vr->region_count++;
+}
+
+/*
+ * Add a cell to a region.
+ * @return 0 if the region already holds N cells (a bad layout)
+ */
+static int add_region_cell(variant *vr, int reg, int cell) {
+  region *rg = &vr->regions[reg];
+  if (rg->size == N || vr->cell_region_count[cell] == MAX_CELL_REGIONS) return 0;
+  rg->cells[rg->size++] = cell;
+  vr->cell_regions[cell][vr->cell_region_count[cell]++] = reg;
+  return 1;
+}
+
+/**
+ * Rebuild the region tables from kind, block_of and the killer cages.
+ * @return 1 on success, 0 if a block or cage has more than N cells
+ */
+int variant_build(variant *vr) {
+  int ok = 1;
+  vr->region_count = 0;
+  memset(vr->cell_region_count, 0, sizeof(vr->cell_region_count));
+
+  for (int r = 0; r < N; r++) {
+    int reg = add_region(vr, REGION_ROW, 0);
+    for (int c = 0; c < N; c++) add_region_cell(vr, reg, r * N + c);
   }
 
-  // check column
-  for (int i=0; i<N; i++) {
-    if (a[i][c] == v) return 0;
+  for (int c = 0; c < N; c++) {
+    int reg = add_region(vr, REGION_COL, 0);
+    for (int r = 0; r < N; r++) add_region_cell(vr, reg, r * N + c);
   }
 
-  // check block
-  int block_row = (r / BLOCK) * BLOCK;
-  int block_col = (c / BLOCK) * BLOCK;
-  for (int i=0; i<BLOCK; i++) {
-    for (int j=0; j<BLOCK; j++) {
-      if (a[block_row+i][block_col+j] == v) return 0;
+  int first_block = vr->region_count;
+  for (int b = 0; b < N; b++) add_region(vr, REGION_BLOCK, 0);
+  for (int i = 0; i < CELLS; i++) ok &= add_region_cell(vr, first_block + vr->block_of[i], i);
+
+  if (vr->kind == VARIANT_DIAGONAL) {
+    int main_diag = add_region(vr, REGION_DIAGONAL, 0);
+    for (int i = 0; i < N; i++) add_region_cell(vr, main_diag, i * N + i);
+    int anti_diag = add_region(vr, REGION_DIAGONAL, 0);
+    for (int i = 0; i < N; i++) add_region_cell(vr, anti_diag, i * N + (N - 1 - i));
+  }
+
+  if (vr->kind == VARIANT_KILLER) {
+    int first_cage = vr->region_count;
+    for (int k = 0; k < vr->cage_count; k++) add_region(vr, REGION_CAGE, vr->cage_sum[k]);
+    for (int i = 0; i < CELLS; i++) {
+      if (vr->cage_of[i] >= 0) ok &= add_region_cell(vr, first_cage + vr->cage_of[i], i);
     }
   }
+  return ok;
+}
 
+/**
+ * Set up a variant with the standard BLOCK x BLOCK blocks and no cages.
+ */
+void variant_init(variant *vr, int kind) {
+  vr->kind = kind;
+  for (int i = 0; i < CELLS; i++) {
+    int r = i / N, c = i % N;
+    vr->block_of[i] = (r / BLOCK) * (N / BLOCK) + c / BLOCK;
+    vr->cage_of[i] = -1;
+  }
+  vr->cage_count = 0;
+  variant_build(vr);
+}
+
+/**
+ * Name of a variant kind, as accepted by --variant.
+ */
+const char *variant_name(int kind) {
+  switch (kind) {
+    case VARIANT_DIAGONAL: return "diagonal";
+    case VARIANT_JIGSAW:   return "jigsaw";
+    case VARIANT_KILLER:   return "killer";
+    default:               return "classic";
+  }
+}
+
+/*
+ * Check that all cells of one jigsaw piece (or killer cage, given cage_of)
+ * are orthogonally connected.
+ */
+static int piece_connected(const int block_of[CELLS], int piece) {
+  int stack[CELLS], seen[CELLS] = {0};
+  int top = 0, found = 0, total = 0;
+
+  for (int i = 0; i < CELLS; i++) {
+    if (block_of[i] != piece) continue;
+    total++;
+    if (top == 0 && found == 0) {
+      stack[top++] = i;
+      seen[i] = 1;
+    }
+  }
+
+  while (top > 0) {
+    int cell = stack[--top];
+    int r = cell / N, c = cell % N;
+    int next[4] = { r > 0 ? cell - N : -1, r < N-1 ? cell + N : -1,
+                    c > 0 ? cell - 1 : -1, c < N-1 ? cell + 1 : -1 };
+    found++;
+    for (int k = 0; k < 4; k++) {
+      if (next[k] >= 0 && !seen[next[k]] && block_of[next[k]] == piece) {
+        seen[next[k]] = 1;
+        stack[top++] = next[k];
+      }
+    }
+  }
+  return found == total;
+}
+
+/**
+ * Check a layout read from outside (e.g. a save file): every jigsaw piece has
+ * exactly N connected cells, every killer cage has 1 to N connected cells and
+ * a sum that N distinct values can reach.
+ * @return 1 if the layout is valid
+ */
+int variant_check(const variant *vr) {
+  int size[CELLS] = {0};
+
+  if (vr->kind == VARIANT_JIGSAW) {
+    for (int i = 0; i < CELLS; i++) {
+      if (vr->block_of[i] < 0 || vr->block_of[i] >= N) return 0;
+      size[vr->block_of[i]]++;
+    }
+    for (int b = 0; b < N; b++) {
+      if (size[b] != N || !piece_connected(vr->block_of, b)) return 0;
+    }
+  }
+
+  if (vr->kind == VARIANT_KILLER) {
+    if (vr->cage_count < 1 || vr->cage_count > CELLS) return 0;
+    for (int i = 0; i < CELLS; i++) {
+      if (vr->cage_of[i] < 0 || vr->cage_of[i] >= vr->cage_count) return 0;
+      size[vr->cage_of[i]]++;
+    }
+    for (int k = 0; k < vr->cage_count; k++) {
+      int n = size[k];
+      int min_sum = n * (n + 1) / 2;
+      int max_sum = n * N - n * (n - 1) / 2;
+      if (n < 1 || n > N || !piece_connected(vr->cage_of, k)) return 0;
+      if (vr->cage_sum[k] < min_sum || vr->cage_sum[k] > max_sum) return 0;
+    }
+  }
   return 1;
 }
 
-int solve_count_recursive(int board[N][N], int limit, int *count) {
-  if (*count >= limit) return *count;
+/**
+ * Check that a full board satisfies every region of a built variant:
+ * distinct values in each region, and the exact sum in each killer cage.
+ * @return 1 if the board is a valid solution
+ */
+int solution_valid(const variant *vr, int a[N][N]) {
+  for (int reg = 0; reg < vr->region_count; reg++) {
+    const region *rg = &vr->regions[reg];
+    unsigned seen = 0;
+    int sum = 0;
+    for (int k = 0; k < rg->size; k++) {
+      int v = a[rg->cells[k] / N][rg->cells[k] % N];
+      if (v < 1 || v > N || (seen & (1u << (v - 1)))) return 0;
+      seen |= 1u << (v - 1);
+      sum += v;
+    }
+    if (rg->sum != 0 && sum != rg->sum) return 0;
+  }
+  return 1;
+}
 
-  int row = -1, col = -1;
-  for (int i=0; i<N; i++) {
-    for (int j=0; j<N; j++) {
-      if (board[i][j] == 0) { row = i; col = j; break; }
+/**
+ * Turn the blocks into irregular jigsaw pieces by swapping random pairs of
+ * neighbouring cells between pieces, keeping every piece connected.
+ */
+void randomize_jigsaw(variant *vr) {
+  for (int it = 0; it < 50 * N; it++) {
+    int a = rng_rand() % CELLS;
+    int b = (rng_rand() % 2) ? a + 1 : a + N;
+    if (b >= CELLS || (b == a + 1 && b % N == 0)) continue;
+
+    int pa = vr->block_of[a], pb = vr->block_of[b];
+    if (pa == pb) continue;
+
+    /* move a into pb and a random cell of pb into pa, so sizes stay N */
+    int c = rng_rand() % CELLS;
+    if (vr->block_of[c] != pb) continue;
+
+    vr->block_of[a] = pb;
+    vr->block_of[c] = pa;
+    if (!piece_connected(vr->block_of, pa) || !piece_connected(vr->block_of, pb)) {
+      vr->block_of[a] = pa;
+      vr->block_of[c] = pb;
     }
-    if (row != -1) break;
   }
+  variant_build(vr);
+}
 
-  if (row == -1) { 
-    /* 
+/**
+ * Split a solved board into killer cages of 1 to 3 orthogonally connected
+ * cells with distinct values, and record their sums.
+ */
+void make_killer_cages(variant *vr, int solution[N][N]) {
+  int order[CELLS];
+  for (int i = 0; i < CELLS; i++) {
+    order[i] = i;
+    vr->cage_of[i] = -1;
+  }
+  for (int i = CELLS - 1; i > 0; i--) {
+    int j = rng_rand() % (i + 1);
+    int t = order[i];
+    order[i] = order[j];
+    order[j] = t;
+  }
+
+  vr->cage_count = 0;
+  for (int k = 0; k < CELLS; k++) {
+    int start = order[k];
+    if (vr->cage_of[start] >= 0) continue;
+
+    int cage = vr->cage_count++;
+    int target = 1 + rng_rand() % (N < 3 ? N : 3);
+    int members[3], size = 0;
+    unsigned values = 0;
+
+    vr->cage_of[start] = cage;
+    members[size++] = start;
+    values |= 1u << (solution[start / N][start % N] - 1);
+
+    /* grow the cage from a random member into a random free neighbour */
+    for (int tries = 0; size < target && tries < 8; tries++) {
+      int cell = members[rng_rand() % size];
+      int r = cell / N, c = cell % N;
+      int next[4] = { r > 0 ? cell - N : -1, r < N-1 ? cell + N : -1,
+                      c > 0 ? cell - 1 : -1, c < N-1 ? cell + 1 : -1 };
+      int n = next[rng_rand() % 4];
+      if (n < 0 || vr->cage_of[n] >= 0) continue;
+
+      unsigned bit = 1u << (solution[n / N][n % N] - 1);
+      if (values & bit) continue;
+
+      vr->cage_of[n] = cage;
+      members[size++] = n;
+      values |= bit;
+    }
+
+    vr->cage_sum[cage] = 0;
+    for (int m = 0; m < size; m++) {
+      vr->cage_sum[cage] += solution[members[m] / N][members[m] % N];
+    }
+  }
+  variant_build(vr);
+}
+
+/*
+ * Candidate engine.
+ * used[reg] has bit (v-1) set when value v is already placed in region reg.
+ * The masks are updated once per placement (cand_place), so the candidates of
+ * a cell are the values missing from all of its regions, further narrowed by
+ * the remaining sum of a killer cage.
+ */
+typedef struct {
+  unsigned used[MAX_REGIONS];
+  int sum_left[MAX_REGIONS];    /* killer cages: sum still missing */
+  int empty_left[MAX_REGIONS];  /* empty cells left in the region */
+} cand_state;
+
+/**
+ * Mark value v as placed at cell (r*N + c).
+ */
+void cand_place(cand_state *s, int cell, int v) {
+  unsigned bit = 1u << (v - 1);
+  for (int k = 0; k < game_variant.cell_region_count[cell]; k++) {
+    int reg = game_variant.cell_regions[cell][k];
+    s->used[reg] |= bit;
+    s->sum_left[reg] -= v;
+    s->empty_left[reg]--;
+  }
+}
+
+/**
+ * Undo cand_place().
+ */
+void cand_remove(cand_state *s, int cell, int v) {
+  unsigned bit = 1u << (v - 1);
+  for (int k = 0; k < game_variant.cell_region_count[cell]; k++) {
+    int reg = game_variant.cell_regions[cell][k];
+    s->used[reg] &= ~bit;
+    s->sum_left[reg] += v;
+    s->empty_left[reg]++;
+  }
+}
+
+/**
+ * Build the candidate masks from the current board.
+ */
+void cand_init(cand_state *s, int a[N][N]) {
+  for (int reg = 0; reg < game_variant.region_count; reg++) {
+    s->used[reg] = 0;
+    s->sum_left[reg] = game_variant.regions[reg].sum;
+    s->empty_left[reg] = game_variant.regions[reg].size;
+  }
+  for (int i = 0; i < CELLS; i++) {
+    if (a[i / N][i % N] != 0) {
+      cand_place(s, i, a[i / N][i % N]);
+    }
+  }
+}
+
+/**
+ * Candidate values of an empty cell as a bitmask (bit v-1 = value v).
+ */
+unsigned cand_mask(const cand_state *s, int cell) {
+  unsigned mask = FULL_MASK;
+  for (int k = 0; k < game_variant.cell_region_count[cell]; k++) {
+    int reg = game_variant.cell_regions[cell][k];
+    mask &= ~s->used[reg];
+
+    if (game_variant.regions[reg].sum == 0) continue;
+
+    /*
+     * The other (left-1) empty cells of the cage need at least 1+2+... and
+     * at most N+(N-1)+... of the remaining sum, which bounds this cell's value.
+     */
+    int left = s->empty_left[reg] - 1;
+    int lo = s->sum_left[reg] - (left * N - left * (left - 1) / 2);
+    int hi = s->sum_left[reg] - left * (left + 1) / 2;
+    if (lo < 1) lo = 1;
+    if (hi > N) hi = N;
+    if (lo > hi) return 0;
+    mask &= ((1u << hi) - 1) & ~((1u << (lo - 1)) - 1);
+  }
+  return mask;
+}
+
+/*
+ * Find the empty cell with the fewest candidates.
+ * @return The cell index, or -1 if the board is full
+ */
+static int pick_cell(const cand_state *s, int board[N][N], unsigned *mask) {
+  int best = -1, best_count = N + 1;
+  for (int i = 0; i < CELLS; i++) {
+    if (board[i / N][i % N] != 0) continue;
+
+    unsigned m = cand_mask(s, i);
+    int count = __builtin_popcount(m);
+    if (count < best_count) {
+      best = i;
+      best_count = count;
+      *mask = m;
+      if (count <= 1) break;
+    }
+  }
+  return best;
+}
+
+int solve_count_recursive(cand_state *s, int board[N][N], int limit, int *count) {
+  if (*count >= limit) return *count;
+
+  unsigned mask = 0;
+  int cell = pick_cell(s, board, &mask);
+
+  if (cell == -1) {
+    /*
      * If we've reached the end of the board without finding any empty cells,
      * then we've found a valid solution. Increment the solution count.
      */
-    (*count)++; 
-    return *count; 
+    (*count)++;
+    return *count;
   }
 
-  for (int v=1; v<=N; v++) {
-    if (is_valid(board, row, col, v)) {
-      board[row][col] = v;
-      solve_count_recursive(board, limit, count);
-      board[row][col] = 0;
-      
-      if (*count >= limit) {
-        return *count;
-      }
+  int row = cell / N, col = cell % N;
+  while (mask) {
+    int v = __builtin_ctz(mask) + 1;
+    mask &= mask - 1;
+
+    board[row][col] = v;
+    cand_place(s, cell, v);
+    solve_count_recursive(s, board, limit, count);
+    cand_remove(s, cell, v);
+    board[row][col] = 0;
+
+    if (*count >= limit) {
+      return *count;
     }
   }
   return *count;
@@ -174,12 +591,81 @@ int count_solutions(int a[N][N], int limit) {
   int tmp[N][N];
   copy_board(tmp, a);
 
+  cand_state s;
+  cand_init(&s, tmp);
+
   int cnt = 0;
-  solve_count_recursive(tmp, limit, &cnt);
-  
+  solve_count_recursive(&s, tmp, limit, &cnt);
+
   return cnt;
 }
 
+/*
+ * Fill the empty cells depth-first, trying candidates in increasing order or,
+ * with shuffle set, in random order.
+ */
+static int fill_recursive(cand_state *s, int board[N][N], int shuffle) {
+  unsigned mask = 0;
+  int cell = pick_cell(s, board, &mask);
+  if (cell == -1) return 1;
+
+  int values[N], count = 0;
+  while (mask) {
+    values[count++] = __builtin_ctz(mask) + 1;
+    mask &= mask - 1;
+  }
+  for (int i = count - 1; shuffle && i > 0; i--) {
+    int j = rng_rand() % (i + 1);
+    int t = values[i];
+    values[i] = values[j];
+    values[j] = t;
+  }
+
+  for (int i = 0; i < count; i++) {
+    board[cell / N][cell % N] = values[i];
+    cand_place(s, cell, values[i]);
+    if (fill_recursive(s, board, shuffle)) return 1;
+    cand_remove(s, cell, values[i]);
+    board[cell / N][cell % N] = 0;
+  }
+  return 0;
+}
+
+/**
+ * Solve a puzzle of game_variant in place.
+ * @return 1 on success, 0 if the givens conflict or there is no solution
+ */
+int solve_board(int a[N][N]) {
+  int tmp[N][N];
+  memset(tmp, 0, sizeof(tmp));
+
+  cand_state s;
+  cand_init(&s, tmp);
+  for (int i = 0; i < CELLS; i++) {
+    int v = a[i / N][i % N];
+    if (v == 0) continue;
+    if (!(cand_mask(&s, i) & (1u << (v - 1)))) return 0;
+    tmp[i / N][i % N] = v;
+    cand_place(&s, i, v);
+  }
+
+  if (!fill_recursive(&s, tmp, 0)) return 0;
+  copy_board(a, tmp);
+  return 1;
+}
+
+/**
+ * Fill an empty board with a random solution of game_variant.
+ * @return 1 on success, 0 if the variant has no solution
+ */
+int fill_random_solution(int a[N][N]) {
+  memset(a, 0, sizeof(int) * CELLS);
+
+  cand_state s;
+  cand_init(&s, a);
+  return fill_recursive(&s, a, 1);
+}
+
 void swap_rows(int a[N][N], int r1, int r2) {
   for (int c = 0; c < N; c++) { /* loop over all columns */
     int t = a[r1][c]; /* save the value at row r1, col c */
@@ -230,7 +716,7 @@ void swap_col_blocks(int a[N][N], int b1, int b2) {
 
 void randomize_solution(int a[N][N]) {
   for (int it=0; it<50; it++) {
-    int t = rand()%5;
+    int t = rng_rand()%5;
 
     /*
      * Transformation 0: swap two rows in the same block.
@@ -238,9 +724,9 @@ void randomize_solution(int a[N][N]) {
      * and swapping the corresponding rows of the Sudoku board.
      */
     if (t == 0) { 
-      int band=rand()%BLOCK; 
-      int r1 = band*BLOCK + rand() % BLOCK; 
-      int r2 = band*BLOCK + rand() % BLOCK; 
+      int band=rng_rand()%BLOCK; 
+      int r1 = band*BLOCK + rng_rand() % BLOCK; 
+      int r2 = band*BLOCK + rng_rand() % BLOCK; 
       
       if (r1!=r2) { 
         swap_rows(a,r1,r2); 
@@ -252,9 +738,9 @@ void randomize_solution(int a[N][N]) {
      * and swapping the corresponding columns of the Sudoku board.
      */
     else if (t == 1) { 
-      int band=rand()%BLOCK; 
-      int c1 = band * BLOCK + rand() % BLOCK; 
-      int c2 = band * BLOCK + rand() % BLOCK; 
+      int band=rng_rand()%BLOCK; 
+      int c1 = band * BLOCK + rng_rand() % BLOCK; 
+      int c2 = band * BLOCK + rng_rand() % BLOCK; 
       
       if (c1 != c2) {
         swap_cols(a,c1,c2); 
@@ -266,7 +752,7 @@ void randomize_solution(int a[N][N]) {
      * swapping the corresponding blocks of rows in the Sudoku board.
      */
     else if (t == 2) { 
-      int b1 = rand() % BLOCK, b2 = rand() % BLOCK; 
+      int b1 = rng_rand() % BLOCK, b2 = rng_rand() % BLOCK; 
       
       if (b1 != b2) {
         swap_row_blocks(a, b1, b2); 
@@ -278,7 +764,7 @@ void randomize_solution(int a[N][N]) {
      * swapping the corresponding blocks of columns in the Sudoku board.
      */
     else if (t == 3) { 
-      int b1 = rand() % BLOCK, b2 = rand() % BLOCK; 
+      int b1 = rng_rand() % BLOCK, b2 = rng_rand() % BLOCK; 
       
       if (b1 != b2) {
         swap_col_blocks(a, b1, b2); 
@@ -289,25 +775,63 @@ void randomize_solution(int a[N][N]) {
      * This transformation is done by swapping the rows and columns of the Sudoku board.
      */
     else { 
-      if (rand() % 3 == 0) {
+      if (rng_rand() % 3 == 0) {
         transpose_board(a); 
       }
     }
   }
 }
 
-void generate_puzzle(int a[N][N], int blanks) {
+/**
+ * Set up game_variant of the given kind together with a random solution.
+ * Classic and killer boards come from base_solved via randomize_solution();
+ * the transformations do not preserve diagonals or jigsaw pieces, so those
+ * variants are filled by the solver instead.
+ */
+void generate_solution(int a[N][N], int kind) {
+  variant_init(&game_variant, kind);
+
+  if (kind == VARIANT_CLASSIC || kind == VARIANT_KILLER) {
+    copy_board(a, base_solved);
+    randomize_solution(a);
+    if (kind == VARIANT_KILLER) {
+      make_killer_cages(&game_variant, a);
+    }
+    return;
+  }
+
+  /* not every jigsaw layout can be solved, so try a few */
+  for (int attempt = 0; attempt < 100; attempt++) {
+    if (kind == VARIANT_JIGSAW) {
+      randomize_jigsaw(&game_variant);
+    }
+    if (fill_random_solution(a)) {
+      return;
+    }
+    variant_init(&game_variant, kind);
+  }
+
+  /* the regular blocks are a valid jigsaw layout as well */
+  fill_random_solution(a);
+}
+
+/**
+ * Remove up to `blanks` cells from a solved board while keeping the solution
+ * unique.
+ * @return Number of cells actually removed
+ */
+int generate_puzzle(int a[N][N], int blanks) {
   /* initialize an array of positions to shuffle */
-  int pos[16];
+  int pos[CELLS];
 
   /* initialize the array of positions */
-  for ( int i = 0; i < 16; i++ ) {
+  for ( int i = 0; i < CELLS; i++ ) {
     pos[i] = i;
   }
 
   /* shuffle the array of positions */
-  for ( int i = 15; i > 0; i-- ) {
-    int j = rand() % ( i + 1 );
+  for ( int i = CELLS - 1; i > 0; i-- ) {
+    int j = rng_rand() % ( i + 1 );
     int t = pos[i];
     
     pos[i] = pos[j];
@@ -318,7 +842,7 @@ void generate_puzzle(int a[N][N], int blanks) {
   int removed = 0;
 
   /* loop over the shuffled positions and remove cells while keeping a unique solution */
-  for ( int k = 0; k < 16 && removed < blanks; k++ ) {
+  for ( int k = 0; k < CELLS && removed < blanks; k++ ) {
     int p = pos[k];
     int r = p / N, c = p % N;
 
@@ -343,10 +867,7 @@ void generate_puzzle(int a[N][N], int blanks) {
     }
   }
 
-  /* if the number of removed cells is less than the number of blanks, then print a warning */
-  if ( removed < blanks ) {
-    fprintf(stderr, "WARNING: Hanya bisa menghapus %d dari %d.\n", removed, blanks);
-  }
+  return removed;
 }
 
 int is_full(int a[N][N]) {
@@ -364,6 +885,808 @@ int is_full(int a[N][N]) {
   return 1;
 }
 
+/**
+ * Print the extra rules of game_variant below the board: the piece map of a
+ * jigsaw, or the cage map and sums of a killer puzzle.
+ */
+void print_variant(void) {
+  if (game_variant.kind == VARIANT_DIAGONAL) {
+    printf("Diagonal: kedua diagonal juga berisi angka 1-%d.\n", N);
+  }
+  else if (game_variant.kind == VARIANT_JIGSAW || game_variant.kind == VARIANT_KILLER) {
+    int killer = (game_variant.kind == VARIANT_KILLER);
+    printf(killer ? "Kandang (jumlah harus tepat):\n" : "Blok jigsaw (pengganti blok 2x2):\n");
+
+    for (int r = 0; r < N; r++) {
+      printf("  ");
+      for (int c = 0; c < N; c++) {
+        int id = killer ? game_variant.cage_of[r * N + c] : game_variant.block_of[r * N + c];
+        printf(" %c", (killer ? 'a' : 'A') + id);
+      }
+      printf("\n");
+    }
+
+    if (killer) {
+      for (int k = 0; k < game_variant.cage_count; k++) {
+        printf("  %c=%d", 'a' + k, game_variant.cage_sum[k]);
+      }
+      printf("\n");
+    }
+  }
+}
+
+/*
+ * Hint engine.
+ * Works on the candidate masks of the candidate engine, which main() keeps in
+ * sync with every move, so a hint is a scan over the masks instead of a solve.
+ */
+enum {
+  HINT_NONE = 0,
+  HINT_NAKED_SINGLE,
+  HINT_HIDDEN_ROW,
+  HINT_HIDDEN_COL,
+  HINT_HIDDEN_BLOCK,
+  HINT_HIDDEN_DIAGONAL,
+  HINT_HIDDEN_CAGE
+};
+
+/*
+ * Look for a hidden single in one region holding all N values: a value that
+ * is a candidate in exactly one empty cell of the region.
+ * "once" collects values seen at least once, "twice" those seen more than once.
+ */
+static int find_hidden_single(const cand_state *s, int a[N][N], const region *rg,
+                              int *out_r, int *out_c, int *out_v) {
+  unsigned once = 0, twice = 0;
+  for (int k = 0; k < rg->size; k++) {
+    int cell = rg->cells[k];
+    if (a[cell / N][cell % N] != 0) continue;
+    unsigned cand = cand_mask(s, cell);
+    twice |= once & cand;
+    once |= cand;
+  }
+
+  unsigned single = once & ~twice;
+  if (single == 0) return 0;
+
+  for (int k = 0; k < rg->size; k++) {
+    int cell = rg->cells[k];
+    if (a[cell / N][cell % N] != 0) continue;
+    unsigned hit = cand_mask(s, cell) & single;
+    if (hit) {
+      *out_r = cell / N;
+      *out_c = cell % N;
+      *out_v = __builtin_ctz(hit) + 1;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Find the next logically forced move on the board.
+ * Naked singles are tried first, then hidden singles in rows, columns, blocks
+ * and the variant's extra regions.
+ * @return One of the HINT_* techniques, or HINT_NONE if no single exists
+ */
+int find_hint(const cand_state *s, int a[N][N], int *out_r, int *out_c, int *out_v) {
+  // naked single: a cell with exactly one candidate
+  for (int i = 0; i < CELLS; i++) {
+    if (a[i / N][i % N] != 0) continue;
+    unsigned cand = cand_mask(s, i);
+    if (cand != 0 && (cand & (cand - 1)) == 0) {
+      *out_r = i / N;
+      *out_c = i % N;
+      *out_v = __builtin_ctz(cand) + 1;
+      return HINT_NAKED_SINGLE;
+    }
+  }
+
+  // hidden single in a region that must contain every value
+  for (int reg = 0; reg < game_variant.region_count; reg++) {
+    const region *rg = &game_variant.regions[reg];
+    if (rg->size != N) continue;
+    if (find_hidden_single(s, a, rg, out_r, out_c, out_v)) {
+      switch (rg->kind) {
+        case REGION_ROW:      return HINT_HIDDEN_ROW;
+        case REGION_COL:      return HINT_HIDDEN_COL;
+        case REGION_DIAGONAL: return HINT_HIDDEN_DIAGONAL;
+        case REGION_CAGE:     return HINT_HIDDEN_CAGE;
+        default:              return HINT_HIDDEN_BLOCK;
+      }
+    }
+  }
+
+  return HINT_NONE;
+}
+
+/**
+ * Human readable name of a hint technique.
+ */
+const char *hint_technique_name(int technique) {
+  switch (technique) {
+    case HINT_NAKED_SINGLE:    return "satu-satunya kandidat di sel ini";
+    case HINT_HIDDEN_ROW:      return "satu-satunya tempat di baris ini";
+    case HINT_HIDDEN_COL:      return "satu-satunya tempat di kolom ini";
+    case HINT_HIDDEN_BLOCK:    return "satu-satunya tempat di blok ini";
+    case HINT_HIDDEN_DIAGONAL: return "satu-satunya tempat di diagonal ini";
+    case HINT_HIDDEN_CAGE:     return "satu-satunya tempat di kandang ini";
+    default:                   return "tidak ada";
+  }
+}
+
+/*
+ * Session snapshot and move log.
+ *
+ * A save file is a snapshot followed by an append-only log of moves made
+ * after it. All integers are little-endian.
+ *
+ *   0   'S' 'K' version N
+ *   4   elapsed time in tenths of a second (u32)
+ *   8   score (i32)
+ *   12  solution, VALUE_BITS per cell storing v-1, row-major
+ *   ..  given mask, one bit per cell
+ *   ..  filled mask, one bit per non-given cell the player has filled
+ *   ..  variant kind (version 2 and later; version 1 is always classic)
+ *   ..  jigsaw: piece of every cell, VALUE_BITS each
+ *       killer: cage count, cage of every cell (CELL_BITS each), cage sums
+ *
+ * Every move record is MOVE_BYTES long: a u16 move code (cell*N + v-1) and
+ * a u16 time delta in tenths of a second since the previous record. Restoring
+ * is unpack + replay of the short tail; saving again compacts the log back
+ * into the snapshot. A classic 4x4 snapshot is 21 bytes. Classic, diagonal
+ * and jigsaw snapshots have a fixed size per kind; killer snapshots grow with
+ * the cage count, up to SNAPSHOT_MAX_BYTES, so a server storing many sessions
+ * back to back should give each one a SNAPSHOT_MAX_BYTES slot.
+ */
+#define SNAPSHOT_VERSION 2
+#define VALUE_BITS (N <= 2 ? 1 : N <= 4 ? 2 : N <= 8 ? 3 : N <= 16 ? 4 : 5)
+#define CELL_BITS (CELLS <= 16 ? 4 : CELLS <= 64 ? 6 : CELLS <= 256 ? 8 : 10)
+#define SOLUTION_BYTES ((CELLS * VALUE_BITS + 7) / 8)
+#define MASK_BYTES ((CELLS + 7) / 8)
+#define SNAPSHOT_BASE_BYTES (12 + SOLUTION_BYTES + 2 * MASK_BYTES)
+#define SNAPSHOT_MAX_BYTES (SNAPSHOT_BASE_BYTES + 2 + (CELLS * CELL_BITS + 7) / 8 + CELLS)
+#define MOVE_BYTES 4
+#define SAVE_FILE "sudoku.sav"
+
+static void put_u16(unsigned char *p, unsigned v) {
+  p[0] = (unsigned char)(v & 0xff);
+  p[1] = (unsigned char)((v >> 8) & 0xff);
+}
+
+static unsigned get_u16(const unsigned char *p) {
+  return (unsigned)p[0] | ((unsigned)p[1] << 8);
+}
+
+static void put_u32(unsigned char *p, unsigned long v) {
+  put_u16(p, (unsigned)(v & 0xffff));
+  put_u16(p + 2, (unsigned)((v >> 16) & 0xffff));
+}
+
+static unsigned long get_u32(const unsigned char *p) {
+  return (unsigned long)get_u16(p) | ((unsigned long)get_u16(p + 2) << 16);
+}
+
+/*
+ * Append nbits of value at bit offset *pos (LSB first). The buffer must be
+ * zeroed beforehand.
+ */
+static void put_bits(unsigned char *buf, int *pos, unsigned value, int nbits) {
+  for (int i = 0; i < nbits; i++, (*pos)++) {
+    if (value & (1u << i)) {
+      buf[*pos / 8] |= (unsigned char)(1u << (*pos % 8));
+    }
+  }
+}
+
+static unsigned get_bits(const unsigned char *buf, int *pos, int nbits) {
+  unsigned value = 0;
+  for (int i = 0; i < nbits; i++, (*pos)++) {
+    if (buf[*pos / 8] & (1u << (*pos % 8))) {
+      value |= 1u << i;
+    }
+  }
+  return value;
+}
+
+/**
+ * Pack a session of game_variant into a SNAPSHOT_MAX_BYTES buffer.
+ * @return Number of bytes used
+ */
+int pack_snapshot(unsigned char buf[SNAPSHOT_MAX_BYTES], int board[N][N], int solution[N][N],
+                  int given[N][N], double elapsed_seconds, int score) {
+  memset(buf, 0, SNAPSHOT_MAX_BYTES);
+  buf[0] = 'S';
+  buf[1] = 'K';
+  buf[2] = SNAPSHOT_VERSION;
+  buf[3] = N;
+  put_u32(buf + 4, (unsigned long)(elapsed_seconds * 10));
+  put_u32(buf + 8, (unsigned long)score);
+
+  int pos = 0;
+  for (int i = 0; i < CELLS; i++) {
+    put_bits(buf + 12, &pos, (unsigned)(solution[i / N][i % N] - 1), VALUE_BITS);
+  }
+
+  unsigned char *given_mask = buf + 12 + SOLUTION_BYTES;
+  unsigned char *filled_mask = given_mask + MASK_BYTES;
+  for (int i = 0; i < CELLS; i++) {
+    int r = i / N, c = i % N;
+    if (given[r][c]) {
+      given_mask[i / 8] |= (unsigned char)(1u << (i % 8));
+    } else if (board[r][c] != 0) {
+      filled_mask[i / 8] |= (unsigned char)(1u << (i % 8));
+    }
+  }
+
+  unsigned char *p = buf + SNAPSHOT_BASE_BYTES;
+  *p++ = (unsigned char)game_variant.kind;
+
+  if (game_variant.kind == VARIANT_JIGSAW) {
+    pos = 0;
+    for (int i = 0; i < CELLS; i++) {
+      put_bits(p, &pos, (unsigned)game_variant.block_of[i], VALUE_BITS);
+    }
+    p += (CELLS * VALUE_BITS + 7) / 8;
+  }
+  else if (game_variant.kind == VARIANT_KILLER) {
+    *p++ = (unsigned char)game_variant.cage_count;
+    pos = 0;
+    for (int i = 0; i < CELLS; i++) {
+      put_bits(p, &pos, (unsigned)game_variant.cage_of[i], CELL_BITS);
+    }
+    p += (CELLS * CELL_BITS + 7) / 8;
+    for (int k = 0; k < game_variant.cage_count; k++) {
+      *p++ = (unsigned char)game_variant.cage_sum[k];
+    }
+  }
+  return (int)(p - buf);
+}
+
+/**
+ * Unpack a snapshot buffer into a session and set up game_variant.
+ * @return Number of bytes used, or 0 if the buffer does not hold a complete
+ *         snapshot for this grid size
+ */
+int unpack_snapshot(const unsigned char *buf, int len, int board[N][N], int solution[N][N],
+                    int given[N][N], double *elapsed_seconds, int *score) {
+  if (len < SNAPSHOT_BASE_BYTES || buf[0] != 'S' || buf[1] != 'K' || buf[3] != N) {
+    return 0;
+  }
+  if (buf[2] < 1 || buf[2] > SNAPSHOT_VERSION) {
+    return 0;
+  }
+
+  *elapsed_seconds = get_u32(buf + 4) / 10.0;
+  *score = (int)(long)get_u32(buf + 8);
+
+  int pos = 0;
+  for (int i = 0; i < CELLS; i++) {
+    solution[i / N][i % N] = (int)get_bits(buf + 12, &pos, VALUE_BITS) + 1;
+  }
+
+  const unsigned char *given_mask = buf + 12 + SOLUTION_BYTES;
+  const unsigned char *filled_mask = given_mask + MASK_BYTES;
+  for (int i = 0; i < CELLS; i++) {
+    int r = i / N, c = i % N;
+    given[r][c] = (given_mask[i / 8] >> (i % 8)) & 1;
+    int filled = given[r][c] || ((filled_mask[i / 8] >> (i % 8)) & 1);
+    board[r][c] = filled ? solution[r][c] : 0;
+  }
+
+  const unsigned char *p = buf + SNAPSHOT_BASE_BYTES;
+  const unsigned char *end = buf + len;
+
+  /* build the layout aside and only install it once it checks out */
+  variant vr;
+  if (buf[2] == 1) {
+    variant_init(&vr, VARIANT_CLASSIC);
+  } else {
+    if (p >= end || *p > VARIANT_KILLER) return 0;
+    variant_init(&vr, *p++);
+  }
+
+  if (vr.kind == VARIANT_JIGSAW) {
+    if (end - p < (CELLS * VALUE_BITS + 7) / 8) return 0;
+    pos = 0;
+    for (int i = 0; i < CELLS; i++) {
+      vr.block_of[i] = (int)get_bits(p, &pos, VALUE_BITS);
+    }
+    p += (CELLS * VALUE_BITS + 7) / 8;
+  }
+  else if (vr.kind == VARIANT_KILLER) {
+    if (p >= end || *p > CELLS) return 0;
+    vr.cage_count = *p++;
+    if (end - p < (CELLS * CELL_BITS + 7) / 8 + vr.cage_count) return 0;
+    pos = 0;
+    for (int i = 0; i < CELLS; i++) {
+      vr.cage_of[i] = (int)get_bits(p, &pos, CELL_BITS);
+    }
+    p += (CELLS * CELL_BITS + 7) / 8;
+    for (int k = 0; k < vr.cage_count; k++) {
+      vr.cage_sum[k] = *p++;
+    }
+  }
+  if (!variant_check(&vr) || !variant_build(&vr) || !solution_valid(&vr, solution)) {
+    return 0;
+  }
+
+  game_variant = vr;
+  return (int)(p - buf);
+}
+
+/**
+ * Write a snapshot to f. Moves logged afterwards are appended to the same file.
+ * @return 1 on success, 0 on write error
+ */
+int save_snapshot(FILE *f, int board[N][N], int solution[N][N], int given[N][N],
+                  double elapsed_seconds, int score) {
+  unsigned char buf[SNAPSHOT_MAX_BYTES];
+  int len = pack_snapshot(buf, board, solution, given, elapsed_seconds, score);
+  return fwrite(buf, 1, len, f) == (size_t)len && fflush(f) == 0;
+}
+
+/*
+ * Flush f through to the disk.
+ */
+static int sync_file(FILE *f) {
+#ifndef _WIN32
+  return fsync(fileno(f)) == 0;
+#else
+  return _commit(_fileno(f)) == 0;
+#endif
+}
+
+/**
+ * Replace the save file at path with a fresh snapshot, without ever leaving
+ * it empty: the snapshot goes to path.tmp, is flushed to disk and then
+ * renamed over path.
+ * @return The save file opened for appending moves, or NULL on failure, in
+ *         which case the old file at path is left untouched
+ */
+FILE *checkpoint_session(const char *path, int board[N][N], int solution[N][N], int given[N][N],
+                         double elapsed_seconds, int score) {
+  char tmp_path[1024];
+  if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path)) return NULL;
+
+  FILE *f = fopen(tmp_path, "wb");
+  if (f == NULL) return NULL;
+
+  int ok = save_snapshot(f, board, solution, given, elapsed_seconds, score) && sync_file(f);
+  if (fclose(f) != 0) ok = 0;
+
+#ifdef _WIN32
+  /* rename() does not replace an existing file on Windows */
+  if (ok) remove(path);
+#endif
+  if (!ok || rename(tmp_path, path) != 0) {
+    remove(tmp_path);
+    return NULL;
+  }
+  return fopen(path, "ab");
+}
+
+/**
+ * Append one move to the log.
+ * @param delta_seconds Time since the previous snapshot or move record
+ * @return 1 on success, 0 on write error
+ */
+int append_move(FILE *f, int r, int c, int v, double delta_seconds) {
+  unsigned char rec[MOVE_BYTES];
+  long delta = (long)(delta_seconds * 10);
+  if (delta > 0xffff) delta = 0xffff;
+  if (delta < 0) delta = 0;
+
+  put_u16(rec, (unsigned)((r * N + c) * N + (v - 1)));
+  put_u16(rec + 2, (unsigned)delta);
+  return fwrite(rec, 1, MOVE_BYTES, f) == MOVE_BYTES && fflush(f) == 0;
+}
+
+/**
+ * Read a snapshot from f and replay the move log that follows it.
+ * Only moves into empty cells are logged, so a valid file is never longer
+ * than a snapshot plus one record per cell. A truncated trailing record
+ * (e.g. from a crash mid-write) is ignored, and replay stops at the first
+ * move that does not match the solution.
+ * @return Number of moves replayed, or -1 if f does not hold a valid snapshot
+ */
+int load_session(FILE *f, int board[N][N], int solution[N][N], int given[N][N],
+                 double *elapsed_seconds, int *score) {
+  unsigned char data[SNAPSHOT_MAX_BYTES + CELLS * MOVE_BYTES];
+  int len = (int)fread(data, 1, sizeof(data), f);
+
+  int used = unpack_snapshot(data, len, board, solution, given, elapsed_seconds, score);
+  if (used == 0) return -1;
+
+  int moves = 0;
+  for (const unsigned char *rec = data + used; rec + MOVE_BYTES <= data + len; rec += MOVE_BYTES) {
+    unsigned code = get_u16(rec);
+    if (code >= CELLS * N) break;
+
+    int cell = (int)(code / N), v = (int)(code % N) + 1;
+    int r = cell / N, c = cell % N;
+    if (given[r][c] || solution[r][c] != v) break;
+
+    board[r][c] = v;
+    *elapsed_seconds += get_u16(rec + 2) / 10.0;
+    moves++;
+  }
+  return moves;
+}
+
+/*
+ * Batch puzzle I/O.
+ *
+ * Corpora are text files with one puzzle per line: CELLS characters, '1'..'N'
+ * for givens and '0' or '.' for blanks. The reader memory-maps the input (or,
+ * on Windows and for pipes, reads it in large chunks) and parses puzzles
+ * straight from those bytes into fixed-size batches. Worker threads take one
+ * batch at a time, format their results into a private output buffer and
+ * write it with a single fwrite, in input order.
+ */
+#define BATCH_SIZE 4096
+#define MAX_THREADS 64
+#define READ_CHUNK (1 << 20)
+#define BAD_PUZZLE 0xff
+
+typedef struct {
+  const char *data;  /* bytes available for parsing */
+  size_t len;
+  size_t pos;
+#ifndef _WIN32
+  void *map;         /* whole input when memory-mapped */
+  size_t map_len;
+#endif
+  FILE *f;           /* otherwise refilled from f in READ_CHUNK reads */
+  char *buf;
+  int eof;
+  int overlong;      /* skipping the rest of a line longer than READ_CHUNK */
+} puzzle_reader;
+
+typedef struct {
+  long seq;          /* batch number; output is written in this order */
+  int count;
+  unsigned char cells[BATCH_SIZE][CELLS];  /* 0 = blank, BAD_PUZZLE in [0] if malformed */
+} puzzle_batch;
+
+/**
+ * Open a corpus for reading; "-" reads standard input.
+ * @return 1 on success, 0 if the file cannot be opened
+ */
+int reader_open(puzzle_reader *rd, const char *path) {
+  memset(rd, 0, sizeof(*rd));
+
+#ifndef _WIN32
+  if (strcmp(path, "-") != 0) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+      void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map != MAP_FAILED) {
+        madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+        close(fd);
+        rd->map = map;
+        rd->map_len = (size_t)st.st_size;
+        rd->data = map;
+        rd->len = rd->map_len;
+        rd->eof = 1;
+        return 1;
+      }
+    }
+    close(fd);
+  }
+#endif
+
+  rd->f = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+  if (rd->f == NULL) return 0;
+  rd->buf = malloc(READ_CHUNK);
+  if (rd->buf == NULL) {
+    if (rd->f != stdin) fclose(rd->f);
+    return 0;
+  }
+  rd->data = rd->buf;
+  return 1;
+}
+
+void reader_close(puzzle_reader *rd) {
+#ifndef _WIN32
+  if (rd->map) munmap(rd->map, rd->map_len);
+#endif
+  if (rd->f && rd->f != stdin) fclose(rd->f);
+  free(rd->buf);
+}
+
+/*
+ * Keep the unparsed tail and read more bytes after it.
+ * @return 1 if new bytes were read
+ */
+static int reader_refill(puzzle_reader *rd) {
+  if (rd->eof) return 0;
+
+  size_t tail = rd->len - rd->pos;
+  memmove(rd->buf, rd->buf + rd->pos, tail);
+  rd->pos = 0;
+  rd->len = tail;
+
+  size_t n = fread(rd->buf + tail, 1, READ_CHUNK - tail, rd->f);
+  rd->len += n;
+  if (n == 0) rd->eof = 1;
+  return n > 0;
+}
+
+/*
+ * Parse one line into cells; a line of the wrong length or with a character
+ * outside 0-N and '.' is marked BAD_PUZZLE.
+ */
+static void parse_puzzle(const char *line, size_t len, unsigned char cells[CELLS]) {
+  if (len != CELLS) {
+    cells[0] = BAD_PUZZLE;
+    return;
+  }
+  for (int i = 0; i < CELLS; i++) {
+    char ch = line[i];
+    if (ch == '.' || ch == '0') {
+      cells[i] = 0;
+    } else if (ch >= '1' && ch <= '0' + N) {
+      cells[i] = (unsigned char)(ch - '0');
+    } else {
+      cells[0] = BAD_PUZZLE;
+      return;
+    }
+  }
+}
+
+/**
+ * Parse up to BATCH_SIZE puzzles into b. Empty lines are skipped.
+ * @return Number of puzzles in the batch, 0 at end of input
+ */
+int reader_next_batch(puzzle_reader *rd, puzzle_batch *b) {
+  b->count = 0;
+  while (b->count < BATCH_SIZE) {
+    const char *line = rd->data + rd->pos;
+    const char *nl = memchr(line, '\n', rd->len - rd->pos);
+    size_t next;
+
+    if (nl == NULL) {
+      if (rd->f && rd->len - rd->pos == READ_CHUNK) {
+        /* the line does not fit the buffer: drop it and skip to its end */
+        rd->pos = rd->len;
+        rd->overlong = 1;
+      }
+      if (reader_refill(rd)) continue;
+      if (rd->pos >= rd->len) {
+        if (!rd->overlong) break;
+        rd->overlong = 0;
+        b->cells[b->count++][0] = BAD_PUZZLE;
+        continue;
+      }
+      nl = rd->data + rd->len;  /* last line without a newline */
+      next = rd->len;
+    } else {
+      next = (size_t)(nl - rd->data) + 1;
+    }
+
+    size_t len = (size_t)(nl - line);
+    rd->pos = next;
+    if (len > 0 && line[len - 1] == '\r') len--;
+    if (rd->overlong) {
+      rd->overlong = 0;
+      b->cells[b->count++][0] = BAD_PUZZLE;
+      continue;
+    }
+    if (len == 0) continue;
+
+    parse_puzzle(line, len, b->cells[b->count++]);
+  }
+  return b->count;
+}
+
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t turn;
+  puzzle_reader *reader;  /* solving: input corpus */
+  long remaining;         /* generating: puzzles still to hand out */
+  int blanks;
+  long next_seq;          /* next batch number to hand out */
+  long write_seq;         /* next batch number to write */
+  FILE *out;
+  int write_failed;
+  unsigned seed;
+  int worker_count;       /* gives every worker its own random seed */
+} batch_job;
+
+/*
+ * Format a board as one corpus line ('.' for blanks) plus a newline.
+ */
+static char *format_board(char *p, int a[N][N]) {
+  for (int i = 0; i < CELLS; i++) {
+    int v = a[i / N][i % N];
+    *p++ = v ? (char)('0' + v) : '.';
+  }
+  *p++ = '\n';
+  return p;
+}
+
+static void *batch_worker(void *arg) {
+  batch_job *job = arg;
+  puzzle_batch *b = malloc(sizeof(*b));
+  char *out = malloc((size_t)BATCH_SIZE * (CELLS + 1));
+  if (b == NULL || out == NULL) {
+    free(b);
+    free(out);
+    return NULL;
+  }
+
+  pthread_mutex_lock(&job->lock);
+  rng_seed(job->seed + 2654435761u * (unsigned)++job->worker_count);
+  pthread_mutex_unlock(&job->lock);
+
+  while (1) {
+    pthread_mutex_lock(&job->lock);
+    if (job->reader) {
+      reader_next_batch(job->reader, b);
+    } else {
+      b->count = job->remaining < BATCH_SIZE ? (int)job->remaining : BATCH_SIZE;
+      job->remaining -= b->count;
+    }
+    b->seq = job->next_seq;
+    if (b->count > 0) job->next_seq++;
+    pthread_mutex_unlock(&job->lock);
+
+    if (b->count == 0) break;
+
+    char *p = out;
+    int board[N][N];
+    for (int k = 0; k < b->count; k++) {
+      if (job->reader) {
+        /* solved puzzle, or "-" for a malformed or unsolvable line */
+        if (b->cells[k][0] == BAD_PUZZLE) {
+          *p++ = '-';
+          *p++ = '\n';
+          continue;
+        }
+        for (int i = 0; i < CELLS; i++) board[i / N][i % N] = b->cells[k][i];
+        if (!solve_board(board)) {
+          *p++ = '-';
+          *p++ = '\n';
+          continue;
+        }
+      } else {
+        if (game_variant.kind == VARIANT_CLASSIC) {
+          copy_board(board, base_solved);
+          randomize_solution(board);
+        } else {
+          fill_random_solution(board);
+        }
+        generate_puzzle(board, job->blanks);
+      }
+      p = format_board(p, board);
+    }
+
+    pthread_mutex_lock(&job->lock);
+    while (job->write_seq != b->seq) {
+      pthread_cond_wait(&job->turn, &job->lock);
+    }
+    if (fwrite(out, 1, (size_t)(p - out), job->out) != (size_t)(p - out)) {
+      job->write_failed = 1;
+    }
+    job->write_seq++;
+    pthread_cond_broadcast(&job->turn);
+    pthread_mutex_unlock(&job->lock);
+  }
+
+  free(b);
+  free(out);
+  return NULL;
+}
+
+/*
+ * Whether out_path names the same existing file as in_path ("-" is standard
+ * input). Opening the output truncates it, which would destroy the input.
+ */
+static int same_file(const char *in_path, const char *out_path) {
+#ifndef _WIN32
+  struct stat in_st, out_st;
+  int in_ok = strcmp(in_path, "-") == 0 ? fstat(STDIN_FILENO, &in_st) : stat(in_path, &in_st);
+  return in_ok == 0 && stat(out_path, &out_st) == 0 &&
+         in_st.st_dev == out_st.st_dev && in_st.st_ino == out_st.st_ino;
+#else
+  char in_full[_MAX_PATH], out_full[_MAX_PATH];
+  return strcmp(in_path, "-") != 0 &&
+         _fullpath(in_full, in_path, sizeof(in_full)) != NULL &&
+         _fullpath(out_full, out_path, sizeof(out_full)) != NULL &&
+         _stricmp(in_full, out_full) == 0;
+#endif
+}
+
+/**
+ * Solve every puzzle of in_path, or generate `count` puzzles with `blanks`
+ * blanks, writing one line per puzzle to out_path ("-" for stdout).
+ * Only variants with a fixed layout (classic, diagonal) are supported, since
+ * jigsaw and killer layouts differ per puzzle.
+ * @return 0 on success, 1 on error
+ */
+int run_batch(const char *in_path, long count, int blanks, const char *out_path, int threads) {
+  puzzle_reader reader;
+  batch_job job;
+  memset(&job, 0, sizeof(job));
+
+  if (game_variant.kind == VARIANT_JIGSAW || game_variant.kind == VARIANT_KILLER) {
+    fprintf(stderr, "ERROR: Mode batch hanya untuk varian classic dan diagonal.\n");
+    return 1;
+  }
+
+  if (in_path != NULL && strcmp(out_path, "-") != 0 && same_file(in_path, out_path)) {
+    fprintf(stderr, "ERROR: Input dan output adalah file yang sama: '%s'.\n", out_path);
+    return 1;
+  }
+
+  if (in_path != NULL) {
+    if (!reader_open(&reader, in_path)) {
+      fprintf(stderr, "ERROR: Tidak bisa membuka '%s'.\n", in_path);
+      return 1;
+    }
+    job.reader = &reader;
+  }
+  job.remaining = count;
+  job.blanks = blanks;
+  job.seed = (unsigned)time(NULL);
+
+  job.out = strcmp(out_path, "-") == 0 ? stdout : fopen(out_path, "wb");
+  if (job.out == NULL) {
+    fprintf(stderr, "ERROR: Tidak bisa menulis '%s'.\n", out_path);
+    if (job.reader) reader_close(&reader);
+    return 1;
+  }
+
+  if (threads < 1) threads = 1;
+  if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+  pthread_mutex_init(&job.lock, NULL);
+  pthread_cond_init(&job.turn, NULL);
+
+  pthread_t workers[MAX_THREADS];
+  int started = 0;
+  for (int t = 0; t < threads; t++) {
+    if (pthread_create(&workers[started], NULL, batch_worker, &job) == 0) {
+      started++;
+    }
+  }
+  if (started == 0) {
+    batch_worker(&job);
+  }
+  for (int t = 0; t < started; t++) {
+    pthread_join(workers[t], NULL);
+  }
+
+  pthread_cond_destroy(&job.turn);
+  pthread_mutex_destroy(&job.lock);
+
+  if (fflush(job.out) != 0) job.write_failed = 1;
+  if (job.out != stdout) fclose(job.out);
+  if (job.reader) reader_close(&reader);
+
+  if (job.write_failed) {
+    fprintf(stderr, "ERROR: Gagal menulis '%s'.\n", out_path);
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Number of worker threads to use by default.
+ */
+int default_threads(void) {
+#ifndef _WIN32
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+#else
+  return 4;
+#endif
+}
+
 /**
  * Calculate score based on elapsed time using time-based formula.
  * Base score decreases over time - faster completion = higher score.
@@ -376,6 +1699,275 @@ int calculate_score(double elapsed_seconds) {
   return base_score - time_penalty;
 }
 
+/*
+ * High-score store.
+ *
+ * Scores are kept in an append-only log of fixed SCORE_RECORD_BYTES records
+ * (little-endian):
+ *
+ *   0   0x5C, N, blanks, variant kind
+ *   4   finish time, unix seconds (u32)
+ *   8   score (i32)
+ *   12  elapsed seconds (u16, saturating)
+ *   14  Fletcher-16 checksum of bytes 0..13
+ *
+ * Appends are buffered and written with one fwrite + fsync per SCORE_BATCH
+ * records (or on score_store_sync). On open the log is streamed once to
+ * rebuild an in-memory top-SCORE_TOP_K index per grid size, blank count and
+ * variant kind.
+ * Records failing their checksum are skipped and reported; only a partial
+ * final record, torn by a crash mid-write, is cut off so later appends stay
+ * aligned. Leaderboard queries only read the index.
+ */
+#define SCORE_FILE "sudoku_scores.log"
+#define SCORE_RECORD_BYTES 16
+#define SCORE_MAGIC 0x5C
+#define SCORE_BATCH 64
+#define SCORE_TOP_K 10
+#define MAX_SCORE_BOARDS 256
+#define SCORE_READ_RECORDS 4096
+
+typedef struct {
+  int score;
+  unsigned long timestamp;
+  int elapsed_seconds;
+} score_entry;
+
+typedef struct {
+  int n;
+  int blanks;
+  int variant_kind;
+  int count;
+  score_entry top[SCORE_TOP_K];  /* best first */
+} score_board;
+
+typedef struct {
+  FILE *f;
+  int write_failed;  /* a batch sync failed since the log was opened */
+  int pending_count;
+  unsigned char pending[SCORE_BATCH * SCORE_RECORD_BYTES];
+  int board_count;
+  score_board boards[MAX_SCORE_BOARDS];
+} score_store;
+
+static unsigned fletcher16(const unsigned char *p, int len) {
+  unsigned a = 0, b = 0;
+  for (int i = 0; i < len; i++) {
+    a = (a + p[i]) % 255;
+    b = (b + a) % 255;
+  }
+  return (b << 8) | a;
+}
+
+static score_board *find_score_board(score_store *st, int n, int blanks, int variant_kind, int create) {
+  for (int i = 0; i < st->board_count; i++) {
+    score_board *sb = &st->boards[i];
+    if (sb->n == n && sb->blanks == blanks && sb->variant_kind == variant_kind) return sb;
+  }
+  if (!create || st->board_count == MAX_SCORE_BOARDS) return NULL;
+
+  score_board *sb = &st->boards[st->board_count++];
+  sb->n = n;
+  sb->blanks = blanks;
+  sb->variant_kind = variant_kind;
+  sb->count = 0;
+  return sb;
+}
+
+/*
+ * Insert an entry into the top-k of its board. Ties keep the older entry first.
+ * @return 1-based rank, or 0 if the entry did not make the top-k
+ */
+static int index_score(score_store *st, int n, int blanks, int variant_kind, const score_entry *e) {
+  score_board *sb = find_score_board(st, n, blanks, variant_kind, 1);
+  if (sb == NULL) return 0;
+
+  int pos = sb->count;
+  while (pos > 0 && sb->top[pos - 1].score < e->score) pos--;
+  if (pos == SCORE_TOP_K) return 0;
+
+  int last = sb->count < SCORE_TOP_K ? sb->count : SCORE_TOP_K - 1;
+  memmove(&sb->top[pos + 1], &sb->top[pos], sizeof(score_entry) * (last - pos));
+  sb->top[pos] = *e;
+  if (sb->count < SCORE_TOP_K) sb->count++;
+  return pos + 1;
+}
+
+/*
+ * Decode and index one record.
+ * @return 1 if the record is valid
+ */
+static int index_record(score_store *st, const unsigned char *rec) {
+  if (rec[0] != SCORE_MAGIC || fletcher16(rec, 14) != get_u16(rec + 14)) return 0;
+
+  score_entry e;
+  e.timestamp = get_u32(rec + 4);
+  e.score = (int)(long)get_u32(rec + 8);
+  e.elapsed_seconds = (int)get_u16(rec + 12);
+  index_score(st, rec[1], rec[2], rec[3], &e);
+  return 1;
+}
+
+static int truncate_file(FILE *f, long len) {
+#ifndef _WIN32
+  return ftruncate(fileno(f), len) == 0;
+#else
+  return _chsize(_fileno(f), len) == 0;
+#endif
+}
+
+/**
+ * Open (or create) the score log and rebuild the top-k index from it.
+ * With read_only set the log is never created or modified.
+ * @return 1 on success, 0 if the log cannot be opened
+ */
+int score_store_open(score_store *st, const char *path, int read_only) {
+  st->write_failed = 0;
+  st->pending_count = 0;
+  st->board_count = 0;
+
+  if (read_only) {
+    st->f = fopen(path, "rb");
+    if (st->f == NULL) return 1;  /* no log yet: empty leaderboard */
+  } else {
+    /* append mode, so games finishing at the same time never overwrite
+       each other's records */
+    st->f = fopen(path, "a+b");
+    if (st->f == NULL) return 0;
+    rewind(st->f);
+  }
+
+  unsigned char *chunk = malloc(SCORE_READ_RECORDS * SCORE_RECORD_BYTES);
+  if (chunk == NULL) {
+    fclose(st->f);
+    st->f = NULL;
+    return 0;
+  }
+
+  /* stream the log in large reads, skipping records that fail their checksum */
+  long total = 0;
+  int bad = 0;
+  size_t n;
+  while ((n = fread(chunk, 1, SCORE_READ_RECORDS * SCORE_RECORD_BYTES, st->f)) > 0) {
+    for (size_t k = 0; k + SCORE_RECORD_BYTES <= n; k += SCORE_RECORD_BYTES) {
+      if (!index_record(st, chunk + k)) bad++;
+    }
+    total += (long)n;
+  }
+  free(chunk);
+
+  if (bad > 0) {
+    fprintf(stderr, "WARNING: %d rekor rusak di %s dilewati.\n", bad, path);
+  }
+
+  /* cut off a partial final record so the next append starts aligned */
+  long whole = total - total % SCORE_RECORD_BYTES;
+  if (!read_only && whole != total) {
+    fflush(st->f);
+    truncate_file(st->f, whole);
+  }
+  fseek(st->f, 0, SEEK_END);  /* switch from reading to appending */
+  return 1;
+}
+
+/**
+ * Write buffered records to the log and fsync it.
+ * @return 1 on success, 0 on write error
+ */
+int score_store_sync(score_store *st) {
+  if (st->pending_count == 0) return 1;
+
+  size_t len = (size_t)st->pending_count * SCORE_RECORD_BYTES;
+  int ok = fwrite(st->pending, 1, len, st->f) == len && fflush(st->f) == 0 && sync_file(st->f);
+  st->pending_count = 0;
+  return ok;
+}
+
+/**
+ * Record a finished game. The record reaches disk with the next batch sync.
+ * @return 1-based rank on the leaderboard of (n, blanks, variant_kind), 0 if
+ *         not in the top-k
+ */
+int score_store_append(score_store *st, int n, int blanks, int variant_kind,
+                       int score, double elapsed_seconds) {
+  score_entry e;
+  e.score = score;
+  e.timestamp = (unsigned long)time(NULL);
+  e.elapsed_seconds = elapsed_seconds > 0xffff ? 0xffff : (int)elapsed_seconds;
+
+  unsigned char *rec = st->pending + st->pending_count * SCORE_RECORD_BYTES;
+  rec[0] = SCORE_MAGIC;
+  rec[1] = (unsigned char)n;
+  rec[2] = (unsigned char)blanks;
+  rec[3] = (unsigned char)variant_kind;
+  put_u32(rec + 4, e.timestamp);
+  put_u32(rec + 8, (unsigned long)score);
+  put_u16(rec + 12, (unsigned)e.elapsed_seconds);
+  put_u16(rec + 14, fletcher16(rec, 14));
+
+  if (++st->pending_count == SCORE_BATCH && !score_store_sync(st)) {
+    st->write_failed = 1;
+  }
+  return index_score(st, n, blanks, variant_kind, &e);
+}
+
+/**
+ * Sync any buffered records and close the log.
+ * @return 1 if every appended record reached disk, 0 on write error
+ */
+int score_store_close(score_store *st) {
+  if (st->f == NULL) return 1;
+  int ok = score_store_sync(st) && !st->write_failed;
+  if (fclose(st->f) != 0) ok = 0;
+  st->f = NULL;
+  return ok;
+}
+
+/**
+ * Leaderboard of one grid size, blank count and variant kind, best first.
+ * @return Number of entries (at most SCORE_TOP_K)
+ */
+int score_store_top(score_store *st, int n, int blanks, int variant_kind, const score_entry **entries) {
+  score_board *sb = find_score_board(st, n, blanks, variant_kind, 0);
+  if (sb == NULL) return 0;
+  *entries = sb->top;
+  return sb->count;
+}
+
+/**
+ * Print the leaderboards of this grid size, limited to one blank count and
+ * one variant kind when those are not negative.
+ */
+void print_leaderboard(score_store *st, int blanks, int variant_kind) {
+  int printed = 0;
+  for (int kind = VARIANT_CLASSIC; kind <= VARIANT_KILLER; kind++) {
+    if (variant_kind >= 0 && kind != variant_kind) continue;
+
+    for (int b = 0; b <= CELLS; b++) {
+      if (blanks >= 0 && b != blanks) continue;
+
+      const score_entry *top;
+      int count = score_store_top(st, N, b, kind, &top);
+      if (count == 0) continue;
+
+      printf("=== SKOR TERTINGGI %dx%d %s, %d blank ===\n", N, N, variant_name(kind), b);
+      for (int i = 0; i < count; i++) {
+        time_t when = (time_t)top[i].timestamp;
+        char date[32];
+        strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime(&when));
+        printf("%2d. %6d  %02d:%02d  %s\n", i + 1, top[i].score,
+               top[i].elapsed_seconds / 60, top[i].elapsed_seconds % 60, date);
+      }
+      printf("\n");
+      printed = 1;
+    }
+  }
+
+  if (!printed) {
+    printf("Belum ada skor.\n");
+  }
+}
+
 /**
  * Clear the console screen for Windows.
  */
@@ -430,37 +2022,158 @@ int main(int argc, char **argv) {
   //   return 0;
   // }
 
-  srand( (unsigned)time(NULL) );
+  rng_seed( (unsigned)time(NULL) );
 
   int blanks = 6; /* default */
-  if ( argc >= 2 ) {
-    int v = atoi(argv[1]);
+  int variant_kind = VARIANT_CLASSIC;
+  const char *load_path = NULL;
+  const char *solve_path = NULL;
+  const char *out_path = "-";
+  long generate_count = -1;
+  int threads = default_threads();
+  int show_scores = 0;
+  int blanks_given = 0;
+  int variant_given = 0;
+  for ( int i = 1; i < argc; i++ ) {
+    // options that need a value; a missing value is an error, not a blank count
+    int needs_value = strcmp(argv[i], "--solve") == 0 || strcmp(argv[i], "--generate") == 0 ||
+                      strcmp(argv[i], "--out") == 0 || strcmp(argv[i], "--threads") == 0 ||
+                      strcmp(argv[i], "--variant") == 0;
+    if ( needs_value && ( i + 1 >= argc || strncmp(argv[i + 1], "--", 2) == 0 ) ) {
+      fprintf(stderr, "ERROR: Opsi %s membutuhkan argumen.\n", argv[i]);
+      return 1;
+    }
+
+    if ( strcmp(argv[i], "--load") == 0 ) {
+      int has_path = ( i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0 );
+      load_path = has_path ? argv[++i] : SAVE_FILE;
+      continue;
+    }
+
+    // batch mode options
+    if ( strcmp(argv[i], "--solve") == 0 ) {
+      solve_path = argv[++i];
+      continue;
+    }
+    if ( strcmp(argv[i], "--generate") == 0 ) {
+      generate_count = atol(argv[++i]);
+      continue;
+    }
+    if ( strcmp(argv[i], "--out") == 0 ) {
+      out_path = argv[++i];
+      continue;
+    }
+    if ( strcmp(argv[i], "--threads") == 0 ) {
+      threads = atoi(argv[++i]);
+      continue;
+    }
+
+    if ( strcmp(argv[i], "--scores") == 0 ) {
+      show_scores = 1;
+      continue;
+    }
+
+    if ( strcmp(argv[i], "--variant") == 0 ) {
+      const char *name = argv[++i];
+      if ( strcmp(name, "diagonal") == 0 ) {
+        variant_kind = VARIANT_DIAGONAL;
+      } else if ( strcmp(name, "jigsaw") == 0 ) {
+        variant_kind = VARIANT_JIGSAW;
+      } else if ( strcmp(name, "killer") == 0 ) {
+        variant_kind = VARIANT_KILLER;
+      } else if ( strcmp(name, "classic") != 0 ) {
+        fprintf(stderr, "ERROR: Varian '%s' tidak dikenal (classic, diagonal, jigsaw, killer).\n", name);
+        return 1;
+      }
+      variant_given = 1;
+      continue;
+    }
+
+    // --in-window is passed by launch_in_new_window()
+    if ( strcmp(argv[i], "--in-window") == 0 ) {
+      continue;
+    }
+    if ( strncmp(argv[i], "--", 2) == 0 ) {
+      fprintf(stderr, "ERROR: Opsi %s tidak dikenal.\n", argv[i]);
+      return 1;
+    }
+
+    int v = atoi(argv[i]);
 
     if ( v >= 0 && v <= 16 ) {
       blanks = v;
+      blanks_given = 1;
     }
   }
 
-  int board[N][N];
-  copy_board(board, base_solved);
-  randomize_solution(board);
+  if ( show_scores ) {
+    static score_store scores;
+    if ( !score_store_open(&scores, SCORE_FILE, 1) ) {
+      fprintf(stderr, "ERROR: Tidak bisa membuka '%s'.\n", SCORE_FILE);
+      return 1;
+    }
+    print_leaderboard(&scores, blanks_given ? blanks : -1, variant_given ? variant_kind : -1);
+    score_store_close(&scores);
+    return 0;
+  }
+
+  if ( solve_path != NULL || generate_count >= 0 ) {
+    variant_init(&game_variant, variant_kind);
+    return run_batch(solve_path, generate_count, blanks, out_path, threads);
+  }
 
+  int board[N][N];
   int solution[N][N];
-  copy_board(solution, board);
+  int given[N][N];
+  double elapsed_seconds = 0;
+  int score = 0;
+  int finished_on_load = 0;
 
-  generate_puzzle(board, blanks);
+  if ( load_path != NULL ) {
+    FILE *f = fopen(load_path, "rb");
+    int moves = f ? load_session(f, board, solution, given, &elapsed_seconds, &score) : -1;
+    if ( f ) {
+      fclose(f);
+    }
 
-  int given[N][N];
-  for ( int i = 0; i < N; i++) {
-    for ( int j = 0; j < N; j++ ) {
-      given[i][j] = (board[i][j] != 0);
+    if ( moves < 0 ) {
+      fprintf(stderr, "ERROR: Tidak bisa memuat '%s'.\n", load_path);
+      return 1;
     }
+
+    // a finished game was scored when it was completed, not on every load
+    finished_on_load = is_full(board);
   }
+  else {
+    generate_solution(board, variant_kind);
+    copy_board(solution, board);
 
-  // Initialize timer
-  clock_t start_time = clock();
-  double elapsed_seconds = 0;
-  int score = 0;
+    int removed = generate_puzzle(board, blanks);
+
+    /* if the number of removed cells is less than the number of blanks, then print a warning */
+    if ( removed < blanks ) {
+      fprintf(stderr, "WARNING: Hanya bisa menghapus %d dari %d.\n", removed, blanks);
+    }
+
+    for ( int i = 0; i < N; i++) {
+      for ( int j = 0; j < N; j++ ) {
+        given[i][j] = (board[i][j] != 0);
+      }
+    }
+  }
+
+  // Save file of this session. After a 'save' (or a load, which is compacted
+  // right away) every accepted move is appended to it.
+  const char *save_path = load_path ? load_path : SAVE_FILE;
+  FILE *save_log = NULL;
+  if ( load_path != NULL ) {
+    save_log = checkpoint_session(save_path, board, solution, given, elapsed_seconds, score);
+  }
+  double logged_seconds = elapsed_seconds;
+
+  // Candidate masks for the hint engine, kept in sync with every move
+  cand_state hints;
+  cand_init(&hints, board);
 
   char line[64];
 
@@ -477,8 +2190,10 @@ int main(int argc, char **argv) {
   printf("   Misalkan: 2 3 4\n");
   printf("   Baris 2, Kolom 3, dan Nilai 4\n");
   printf("\n");
-printf("2. Ketik 'reveal' untuk melihat solusi\n");
-  printf("3. Ketik 'q' untuk keluar\n");
+printf("2. Ketik 'hint' untuk petunjuk langkah berikutnya\n");
+  printf("3. Ketik 'save' untuk menyimpan permainan\n");
+  printf("4. Ketik 'reveal' untuk melihat solusi\n");
+  printf("5. Ketik 'q' untuk keluar\n");
   printf("\n");
   // ? judul akhir
   printf("=== PERMAINAN DIMULAI ===\n");
@@ -487,18 +2202,25 @@ printf("2. Ketik 'reveal' untuk melihat solusi\n");
   // Wait for user to start the game
   printf("Tekan Enter untuk memulai permainan...");
   getchar();
+
+  // Initialize timer once the game starts, continuing from the saved time
+  // when resuming. Uses wall-clock time; clock() stands still while waiting
+  // for input.
+  time_t start_time = time(NULL);
+  double resumed_seconds = elapsed_seconds;
   
   char message[256] = ""; // Store messages to display between refreshes
 
   while (1) {
     // Calculate elapsed time and score
-    elapsed_seconds = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+    elapsed_seconds = resumed_seconds + difftime(time(NULL), start_time);
     score = calculate_score(elapsed_seconds);
     
 // Clear screen and refresh display
     clear_screen();
     
     print_board(board, elapsed_seconds, score);
+    print_variant();
     
     // Display any pending messages
     if (strlen(message) > 0) {
@@ -509,6 +2231,36 @@ printf("2. Ketik 'reveal' untuk melihat solusi\n");
     if (is_full(board)) {
       printf("Selamat! Selesai.\n");
       printf("Final Time: %.2f seconds | Final Score: %d\n", elapsed_seconds, score);
+
+      // Record the score on the leaderboard of this blank count
+      static score_store scores;
+      if (finished_on_load) {
+        printf("Permainan ini sudah selesai sebelumnya; skor tidak dicatat lagi.\n");
+      }
+      else if (score_store_open(&scores, SCORE_FILE, 0)) {
+        int blank_count = 0;
+        for (int i = 0; i < CELLS; i++) {
+          blank_count += !given[i / N][i % N];
+        }
+        int rank = score_store_append(&scores, N, blank_count, game_variant.kind, score, elapsed_seconds);
+        if (!score_store_close(&scores)) {
+          printf("Gagal menyimpan skor ke %s\n", SCORE_FILE);
+        }
+        else if (rank > 0) {
+          printf("Peringkat #%d untuk %s %d blank! Lihat dengan: --scores\n",
+                 rank, variant_name(game_variant.kind), blank_count);
+        }
+      }
+      else {
+        printf("Gagal menyimpan skor ke %s\n", SCORE_FILE);
+      }
+
+      // The session is over, so its save file is not needed anymore
+      if (save_log) {
+        fclose(save_log);
+        save_log = NULL;
+        remove(save_path);
+      }
       break;
     }
 
@@ -531,9 +2283,43 @@ if (strcmp(line,"q") == 0 || strcmp(line,"quit") == 0) {
 if (strcmp(line,"reveal") == 0 || strcmp(line,"r") == 0) {
       printf("\n=== SOLUSI ===\n\n");
       print_board(solution, elapsed_seconds, score);
+
+      // The solution has been shown, so the session must not be resumed
+      // and scored later
+      if (save_log) {
+        fclose(save_log);
+        save_log = NULL;
+        remove(save_path);
+      }
       break;
     }
 
+if (strcmp(line,"hint") == 0 || strcmp(line,"h") == 0) {
+      int hr, hc, hv;
+      int technique = find_hint(&hints, board, &hr, &hc, &hv);
+      if (technique == HINT_NONE) {
+        sprintf(message, "Tidak ada langkah pasti yang ditemukan.");
+      } else {
+        sprintf(message, "Petunjuk: (%d,%d) = %d (%s)", hr+1, hc+1, hv, hint_technique_name(technique));
+      }
+      continue;
+    }
+
+if (strcmp(line,"save") == 0) {
+      FILE *next_log = checkpoint_session(save_path, board, solution, given, elapsed_seconds, score);
+      if (next_log) {
+        if (save_log) {
+          fclose(save_log);
+        }
+        save_log = next_log;
+        logged_seconds = elapsed_seconds;
+        snprintf(message, sizeof(message), "Tersimpan. Lanjutkan dengan: --load %s", save_path);
+      } else {
+        snprintf(message, sizeof(message), "Gagal menyimpan ke %s", save_path);
+      }
+      continue;
+    }
+
     int br, bc, bv;
     int n = sscanf(line, "%d %d %d", &br, &bc, &bv);
 
@@ -558,10 +2344,31 @@ int r = br - 1, c = bc - 1, v = bv;
       continue;
     }
 
+if (board[r][c] == 0) {
+      cand_place(&hints, r * N + c, v);
+      if (save_log) {
+        append_move(save_log, r, c, v, elapsed_seconds - logged_seconds);
+        logged_seconds = elapsed_seconds;
+      }
+    }
 board[r][c] = v;
 
     sprintf(message, "Terisi (%d,%d) = %d", br, bc, v);
   }
 
+  // Leaving a saved game early: checkpoint it so the time played since the
+  // last logged move is kept when it is loaded again
+  if (save_log) {
+    fclose(save_log);
+    elapsed_seconds = resumed_seconds + difftime(time(NULL), start_time);
+    score = calculate_score(elapsed_seconds);
+    save_log = checkpoint_session(save_path, board, solution, given, elapsed_seconds, score);
+    if (save_log) {
+      fclose(save_log);
+    } else {
+      fprintf(stderr, "ERROR: Gagal menyimpan ke %s\n", save_path);
+    }
+  }
+
   return 0;
 }